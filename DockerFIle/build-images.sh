@@ -0,0 +1,52 @@
+#!/bin/bash
+# build-images.sh：构建带版本号的共享基础镜像，再在其上构建各实验分支的镜像
+#   1.toolchain镜像：RISC-V交叉工具链、gdb、编译好的QEMU，REGISTRY/mit6s081-toolchain:TOOLCHAIN_VERSION
+#   2.默认镜像：toolchain + code-server启动脚本，REGISTRY/mit6s081:TOOLCHAIN_VERSION
+#   3.每个分支一个镜像：默认镜像 + 分支源码，REGISTRY/mit6s081:<分支名>
+# 工具链不变时保持TOOLCHAIN_VERSION不变，各分支镜像的底层完全相同，仓库和拉取时只需要处理分支那一层
+#
+# 用法：在DockerFIle目录下执行 ./build-images.sh [分支...]，不给分支时只构建前两个镜像
+# 环境变量：
+#   REGISTRY           镜像名前缀，例如registry.example.com/os/，默认为空
+#   TOOLCHAIN_VERSION  基础镜像的版本号，默认由Dockerfile按QEMU_VERSION生成（qemu<版本>-focal），
+#                      --build-arg QEMU_VERSION=...通过DOCKER_BUILD_ARGS传入时会跟着变；
+#                      只换了工具链而QEMU版本不变时，需要手动指定一个新的版本号
+#   LAB_REPO           实验仓库，默认git://g.csail.mit.edu/xv6-labs-2020
+#   PUSH               设为1时构建完推送到仓库
+# 其他docker build参数（如--build-arg APT_MIRROR=...）可以通过DOCKER_BUILD_ARGS传入
+
+set -euo pipefail
+
+REGISTRY=${REGISTRY:-}
+TOOLCHAIN_VERSION=${TOOLCHAIN_VERSION:-}
+LAB_REPO=${LAB_REPO:-git://g.csail.mit.edu/xv6-labs-2020}
+PUSH=${PUSH:-0}
+read -r -a extra <<<"${DOCKER_BUILD_ARGS:-}"
+
+cd "$(dirname "$0")"
+
+build() {
+    local tag=$1
+    shift
+    docker build "${extra[@]}" -t "$tag" "$@" .
+    [ "$PUSH" = 1 ] && docker push "$tag"
+    return 0
+}
+
+# 1.版本号只在Dockerfile里生成：先构建toolchain，再从它的org.opencontainers.image.version标签取版本号打tag
+iid=$(mktemp)
+trap 'rm -f "$iid"' EXIT
+docker build "${extra[@]}" --target toolchain --iidfile "$iid" \
+    ${TOOLCHAIN_VERSION:+--build-arg TOOLCHAIN_VERSION="$TOOLCHAIN_VERSION"} .
+TOOLCHAIN_VERSION=$(docker image inspect -f '{{ index .Config.Labels "org.opencontainers.image.version" }}' "$(cat "$iid")")
+toolchain=${REGISTRY}mit6s081-toolchain:$TOOLCHAIN_VERSION
+base=${REGISTRY}mit6s081:$TOOLCHAIN_VERSION
+docker tag "$(cat "$iid")" "$toolchain"
+[ "$PUSH" = 1 ] && docker push "$toolchain"
+
+# 2.默认镜像和各分支镜像
+build "$base" --build-arg BASE_IMAGE="$toolchain"
+for branch in "$@"; do
+    build "${REGISTRY}mit6s081:$branch" -f Dockerfile.lab \
+        --build-arg BASE_IMAGE="$base" --build-arg LAB_REPO="$LAB_REPO" --build-arg LAB_BRANCH="$branch"
+done
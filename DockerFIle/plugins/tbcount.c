@@ -0,0 +1,83 @@
+/*
+ * tbcount：QEMU TCG插件，统计每个翻译块（TB）执行的次数
+ *
+ * 翻译时给每个TB插入一条内联的计数指令，不走回调，开销很小；多线程TCG下计数不加锁，
+ * 多个vCPU同时执行同一个TB时可能少计几次，做热点分析足够了。
+ * QEMU退出时按"pc 指令数 执行次数"每行一个TB写到输出文件，由xv6-profile做符号化。
+ *
+ * 用法：-plugin /usr/local/lib/qemu-plugins/libtbcount.so,arg=<输出文件>，不给输出文件时写到stderr
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include <qemu-plugin.h>
+
+/* QEMU 5.2开始要求插件导出API版本号，5.1没有这个宏 */
+#ifdef QEMU_PLUGIN_VERSION
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+#endif
+
+typedef struct {
+    uint64_t pc;
+    uint64_t insns;
+    uint64_t count;
+} TBCount;
+
+/* 同一个pc重新翻译时TB长度可能不同，用pc和指令数一起作为key，Sv39下pc不会用到高16位 */
+static GHashTable *tbs;
+static GMutex lock;
+static const char *out_path;
+
+static void plugin_exit(qemu_plugin_id_t id, void *p)
+{
+    GHashTableIter iter;
+    TBCount *tb;
+    FILE *out = stderr;
+
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        perror(out_path);
+        return;
+    }
+    g_mutex_lock(&lock);
+    g_hash_table_iter_init(&iter, tbs);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &tb)) {
+        if (tb->count) {
+            fprintf(out, "%" PRIx64 " %" PRIu64 " %" PRIu64 "\n", tb->pc, tb->insns, tb->count);
+        }
+    }
+    g_mutex_unlock(&lock);
+    if (out != stderr) {
+        fclose(out);
+    }
+}
+
+static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+{
+    uint64_t pc = qemu_plugin_tb_vaddr(tb);
+    uint64_t insns = qemu_plugin_tb_n_insns(tb);
+    uint64_t key = pc ^ (insns << 48);
+    TBCount *cnt;
+
+    g_mutex_lock(&lock);
+    cnt = g_hash_table_lookup(tbs, &key);
+    if (!cnt) {
+        cnt = g_new0(TBCount, 1);
+        cnt->pc = pc;
+        cnt->insns = insns;
+        g_hash_table_insert(tbs, g_memdup(&key, sizeof(key)), cnt);
+    }
+    g_mutex_unlock(&lock);
+
+    qemu_plugin_register_vcpu_tb_exec_inline(tb, QEMU_PLUGIN_INLINE_ADD_U64, &cnt->count, 1);
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
+                                           int argc, char **argv)
+{
+    out_path = argc > 0 ? g_strdup(argv[0]) : NULL;
+    tbs = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, g_free);
+    qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
+    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+    return 0;
+}
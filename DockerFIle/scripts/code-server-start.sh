@@ -0,0 +1,48 @@
+#!/bin/bash
+# code-server-start：第一次启动时把code-server和插件装到EDITOR_HOME（挂载的volume）里，之后直接启动
+# 镜像里不再打包code-server，同一个volume被多个容器复用时只会下载安装一次
+# 用法同code-server，例如：code-server-start --bind-addr 0.0.0.0:8848 --auth password
+# 环境变量：
+#   EDITOR_HOME          code-server、插件和用户数据的安装位置，默认/opt/code-server
+#   CODE_SERVER_VERSION  默认3.12.0
+#   CODE_SERVER_ARCH     amd64或arm64，默认amd64
+#   CODE_SERVER_URL      下载地址前缀，默认https://github.com.cnpmjs.org/cdr/code-server/releases/download
+
+set -euo pipefail
+
+EDITOR_HOME=${EDITOR_HOME:-/opt/code-server}
+CODE_SERVER_VERSION=${CODE_SERVER_VERSION:-3.12.0}
+CODE_SERVER_ARCH=${CODE_SERVER_ARCH:-amd64}
+CODE_SERVER_URL=${CODE_SERVER_URL:-https://github.com.cnpmjs.org/cdr/code-server/releases/download}
+
+name=code-server-$CODE_SERVER_VERSION-linux-$CODE_SERVER_ARCH
+bin=$EDITOR_HOME/$name/bin/code-server
+ext_dir=$EDITOR_HOME/extensions
+data_dir=$EDITOR_HOME/data
+
+# 在子shell里执行，下载或安装插件失败退出时由trap删掉解压了一半的临时目录
+install_editor() (
+    echo "code-server-start: installing $name into $EDITOR_HOME" >&2
+    # 之前被杀掉的安装（例如容器被强制停止）来不及清理，持有锁时先删掉
+    find "$EDITOR_HOME" -maxdepth 1 -type d -name '.install.*' -exec rm -rf {} +
+    tmp=$(mktemp -d "$EDITOR_HOME/.install.XXXXXX")
+    trap 'rm -rf "$tmp"' EXIT
+    wget -q -O - "$CODE_SERVER_URL/v$CODE_SERVER_VERSION/$name.tar.gz" | tar xz -C "$tmp"
+    # 1.Markdown Extension
+    # 2.Cpp Extension，离线包随镜像一起提供
+    # 3.Material Theme Extension
+    for ext in yzhang.markdown-all-in-one /usr/local/share/code-server/cpptools-linux.vsix equinusocio.vsc-material-theme; do
+        "$tmp/$name/bin/code-server" --extensions-dir "$ext_dir" --user-data-dir "$data_dir" --install-extension "$ext"
+    done
+    # 全部装完再挪到最终位置，中途失败的话下次启动会重新安装
+    mv "$tmp/$name" "$EDITOR_HOME/$name"
+)
+
+# 多个容器共用一个volume同时启动时，只让一个去安装
+if [ ! -x "$bin" ]; then
+    exec 9>"$EDITOR_HOME/.install.lock"
+    flock 9
+    [ -x "$bin" ] || install_editor
+    exec 9>&-
+fi
+exec "$bin" --extensions-dir "$ext_dir" --user-data-dir "$data_dir" "$@"
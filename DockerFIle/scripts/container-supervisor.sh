@@ -0,0 +1,235 @@
+#!/bin/bash
+# container-supervisor：容器的入口进程，启动code-server并统计启动耗时和资源占用
+#   1.在cgroup v2下把code-server和QEMU分到editor、guests两个子cgroup，分别限制内存和CPU，
+#     QEMU由/usr/local/sbin/qemu-system-riscv64（scripts/qemu-guest-cgroup.sh）在启动前进入guests
+#   2.记录从容器启动到code-server的/healthz可以访问的耗时
+#   3.每隔METRICS_INTERVAL秒把两组进程的CPU时间和内存写到METRICS_FILE（Prometheus文本格式），
+#     可以直接交给node_exporter的textfile collector或其他本地采集程序读取
+# 设置cgroup需要cgroup v2，并且容器里的/sys/fs/cgroup可写。Docker在非privileged容器里总是把它挂成只读，
+# 所以要么docker run --privileged，要么--cgroupns=private --cap-add SYS_ADMIN --security-opt apparmor=unconfined，
+# 由supervisor重新挂成可写（默认的AppArmor配置禁止mount）。做不到时只跳过限制，统计改为按/proc里的进程汇总
+#
+# 用法：container-supervisor <命令...>，命令退出后supervisor也随之退出并返回相同的退出码
+# 环境变量：
+#   READY_URL          就绪检查地址，默认http://127.0.0.1:8848/healthz
+#   METRICS_FILE       默认/tmp/mit6s081-metrics.prom
+#   METRICS_INTERVAL   默认5（秒）
+#   EDITOR_MEMORY_MAX  code-server一组的内存上限，字节数、带K/M/G后缀或容器内存的百分比，默认50%
+#   EDITOR_CPU_MAX     code-server一组可用的CPU核数或容器CPU的百分比，默认1
+#   GUEST_MEMORY_MAX   QEMU一组的内存上限，默认max（不限制）
+#   GUEST_CPU_MAX      QEMU一组可用的CPU，默认max（不限制）
+
+set -u
+
+READY_URL=${READY_URL:-http://127.0.0.1:8848/healthz}
+METRICS_FILE=${METRICS_FILE:-/tmp/mit6s081-metrics.prom}
+METRICS_INTERVAL=${METRICS_INTERVAL:-5}
+EDITOR_MEMORY_MAX=${EDITOR_MEMORY_MAX:-50%}
+EDITOR_CPU_MAX=${EDITOR_CPU_MAX:-1}
+GUEST_MEMORY_MAX=${GUEST_MEMORY_MAX:-max}
+GUEST_CPU_MAX=${GUEST_CPU_MAX:-max}
+
+cg=/sys/fs/cgroup
+cgroups=0
+start=$EPOCHREALTIME
+ready=
+page_size=$(getconf PAGESIZE)
+clk_tck=$(getconf CLK_TCK)
+
+log() {
+    echo "container-supervisor: $*" >&2
+}
+
+cg_write() {
+    echo "$2" | sudo -n tee "$cg/$1" >/dev/null 2>&1
+}
+
+# 容器可用的内存字节数和CPU核数，cgroup里没有限制时用整机的
+container_memory() {
+    local max
+    max=$(cat "$cg/memory.max" 2>/dev/null || echo max)
+    if [ "$max" = max ]; then
+        awk '/^MemTotal:/ { print $2 * 1024 }' /proc/meminfo
+    else
+        echo "$max"
+    fi
+}
+
+container_cpus() {
+    local quota period
+    read -r quota period 2>/dev/null <"$cg/cpu.max" || quota=max
+    if [ "$quota" = max ]; then
+        nproc
+    else
+        awk -v q="$quota" -v p="$period" 'BEGIN { print q / p }'
+    fi
+}
+
+# 把EDITOR_MEMORY_MAX这类配置换算成memory.max的写法
+memory_max() {
+    case $1 in
+    max) echo max ;;
+    *%) awk -v p="${1%\%}" -v m="$(container_memory)" 'BEGIN { printf "%.0f", m * p / 100 }' ;;
+    *) numfmt --from=iec "$1" ;;
+    esac
+}
+
+# 把EDITOR_CPU_MAX这类配置换算成cpu.max的写法（每100ms周期内可用的微秒数）
+cpu_max() {
+    case $1 in
+    max) echo "max 100000" ;;
+    *%) awk -v p="${1%\%}" -v c="$(container_cpus)" 'BEGIN { printf "%.0f 100000", c * p * 1000 }' ;;
+    *) awk -v c="$1" 'BEGIN { printf "%.0f 100000", c * 100000 }' ;;
+    esac
+}
+
+# cgroup v2的子树里有进程的节点不能再给子节点开控制器，所以先把容器里已有的进程挪到supervisor叶子节点
+setup_cgroups() {
+    local pid
+    [ -f "$cg/cgroup.controllers" ] || { log "cgroup v2 not available, limits disabled"; return; }
+    # Docker在非privileged容器里把/sys/fs/cgroup挂成只读，有CAP_SYS_ADMIN且AppArmor允许mount时可以重新挂成可写
+    if ! sudo -n mkdir -p "$cg/supervisor" "$cg/editor" "$cg/guests" 2>/dev/null &&
+        ! { sudo -n mount -o remount,rw "$cg" 2>/dev/null &&
+            sudo -n mkdir -p "$cg/supervisor" "$cg/editor" "$cg/guests" 2>/dev/null; }; then
+        log "$cg is read-only, limits disabled (run with --privileged, or --cgroupns=private --cap-add SYS_ADMIN --security-opt apparmor=unconfined)"
+        return
+    fi
+    while read -r pid; do
+        cg_write supervisor/cgroup.procs "$pid"
+    done <"$cg/cgroup.procs"
+    if ! cg_write cgroup.subtree_control "+memory +cpu"; then
+        log "cannot enable memory and cpu controllers, limits disabled"
+        return
+    fi
+    cg_write editor/memory.max "$(memory_max "$EDITOR_MEMORY_MAX")" &&
+        cg_write editor/cpu.max "$(cpu_max "$EDITOR_CPU_MAX")" &&
+        cg_write guests/memory.max "$(memory_max "$GUEST_MEMORY_MAX")" &&
+        cg_write guests/cpu.max "$(cpu_max "$GUEST_CPU_MAX")" ||
+        { log "cannot set limits, limits disabled"; return; }
+    cgroups=1
+}
+
+# QEMU是从code-server的终端里启动的，正常情况下由PATH里的qemu-guest-cgroup在exec之前进入guests；
+# 这里只兜底处理用绝对路径启动的QEMU，挪过来之前已经用掉的内存仍然记在editor上
+move_guests() {
+    local pid comm
+    for pid in $(cat "$cg/editor/cgroup.procs" 2>/dev/null); do
+        read -r comm <"/proc/$pid/comm" 2>/dev/null || continue
+        [[ $comm == qemu-system* ]] && cg_write guests/cgroup.procs "$pid"
+    done
+}
+
+# 没有cgroup时按/proc汇总，QEMU进程算guests，supervisor之外的其他进程都算editor
+# CPU时间要单调递增，已退出进程最后一次统计到的CPU时间累加到exited_ticks里；
+# 进程按"pid:启动时间"区分，避免pid复用，exec后换了组的进程从换组时起算到新的组
+declare -A exited_ticks=([editor]=0 [guests]=0) proc_ticks=() proc_base=() proc_group=()
+
+# 结果放在usage里："editor的CPU秒数 editor的内存字节数 guests的CPU秒数 guests的内存字节数"
+proc_usage() {
+    local stat pid comm rest f g key ticks
+    local -A cpu=([editor]=0 [guests]=0) mem=([editor]=0 [guests]=0) seen=()
+    for stat in /proc/[0-9]*/stat; do
+        pid=${stat#/proc/}
+        pid=${pid%/stat}
+        [ "$pid" = $$ ] && continue
+        IFS= read -r rest <"$stat" 2>/dev/null || continue
+        comm=${rest#*(}
+        comm=${comm%)*}
+        read -r -a f <<<"${rest##*) }"
+        # 去掉pid和comm之后，utime、stime、starttime、rss分别是第12、13、20、22个字段
+        if [[ $comm == qemu-system* ]]; then g=guests; else g=editor; fi
+        key=$pid:${f[19]}
+        ticks=$((f[11] + f[12]))
+        if [ -n "${proc_group[$key]:-}" ] && [ "${proc_group[$key]}" != "$g" ]; then
+            exited_ticks[${proc_group[$key]}]=$((exited_ticks[${proc_group[$key]}] + ${proc_ticks[$key]} - ${proc_base[$key]}))
+            proc_base[$key]=${proc_ticks[$key]}
+        fi
+        proc_group[$key]=$g
+        proc_ticks[$key]=$ticks
+        : "${proc_base[$key]:=0}"
+        seen[$key]=1
+        cpu[$g]=$((cpu[$g] + ticks - ${proc_base[$key]}))
+        mem[$g]=$((mem[$g] + f[21] * page_size))
+    done
+    for key in "${!proc_group[@]}"; do
+        [ -n "${seen[$key]:-}" ] && continue
+        g=${proc_group[$key]}
+        exited_ticks[$g]=$((exited_ticks[$g] + ${proc_ticks[$key]} - ${proc_base[$key]}))
+        unset "proc_group[$key]" "proc_ticks[$key]" "proc_base[$key]"
+    done
+    read -r -a usage < <(awk -v ec="$((cpu[editor] + exited_ticks[editor]))" \
+        -v gc="$((cpu[guests] + exited_ticks[guests]))" -v hz="$clk_tck" \
+        -v em="${mem[editor]}" -v gm="${mem[guests]}" \
+        'BEGIN { printf "%.2f %.0f %.2f %.0f\n", ec / hz, em, gc / hz, gm }')
+}
+
+cgroup_usage() {
+    local g usec
+    for g in editor guests; do
+        usec=$(awk '$1 == "usage_usec" { print $2 }' "$cg/$g/cpu.stat")
+        printf '%s %s ' "$(awk -v u="$usec" 'BEGIN { printf "%.2f", u / 1e6 }')" "$(cat "$cg/$g/memory.current")"
+    done
+    echo
+}
+
+write_metrics() {
+    local usage g tmp=$METRICS_FILE.tmp
+    if [ $cgroups = 1 ]; then
+        move_guests
+        read -r -a usage < <(cgroup_usage)
+    else
+        proc_usage
+    fi
+    {
+        echo "# HELP mit6s081_code_server_ready_seconds Seconds from container start until $READY_URL answered."
+        echo "# TYPE mit6s081_code_server_ready_seconds gauge"
+        [ -n "$ready" ] && echo "mit6s081_code_server_ready_seconds $ready"
+        echo "# HELP mit6s081_cgroup_limits_enabled Whether editor and guest processes run in limited cgroups."
+        echo "# TYPE mit6s081_cgroup_limits_enabled gauge"
+        echo "mit6s081_cgroup_limits_enabled $cgroups"
+        echo "# HELP mit6s081_cpu_seconds_total CPU time used by each process group, including exited processes."
+        echo "# TYPE mit6s081_cpu_seconds_total counter"
+        echo "mit6s081_cpu_seconds_total{group=\"editor\"} ${usage[0]}"
+        echo "mit6s081_cpu_seconds_total{group=\"guests\"} ${usage[2]}"
+        echo "# HELP mit6s081_memory_bytes Memory used by each process group."
+        echo "# TYPE mit6s081_memory_bytes gauge"
+        echo "mit6s081_memory_bytes{group=\"editor\"} ${usage[1]}"
+        echo "mit6s081_memory_bytes{group=\"guests\"} ${usage[3]}"
+        if [ $cgroups = 1 ]; then
+            echo "# HELP mit6s081_memory_limit_bytes memory.max of each process group, 0 means unlimited."
+            echo "# TYPE mit6s081_memory_limit_bytes gauge"
+            for g in editor guests; do
+                echo "mit6s081_memory_limit_bytes{group=\"$g\"} $(sed 's/^max$/0/' "$cg/$g/memory.max")"
+            done
+        fi
+    } >"$tmp" && mv "$tmp" "$METRICS_FILE"
+}
+
+if [ $# -eq 0 ]; then
+    sed -n '12,21s/^# \{0,1\}//p' "$0" >&2
+    exit 2
+fi
+
+setup_cgroups
+# supervisor先临时进入editor再启动子进程，这样子进程从第一条指令起就在editor里
+[ $cgroups = 1 ] && cg_write editor/cgroup.procs $$
+"$@" &
+child=$!
+[ $cgroups = 1 ] && cg_write supervisor/cgroup.procs $$
+trap 'kill -TERM $child 2>/dev/null' TERM INT
+
+next=0
+while kill -0 $child 2>/dev/null; do
+    if [ -z "$ready" ] && wget -q -T 1 -O /dev/null "$READY_URL" 2>/dev/null; then
+        ready=$(awk -v a="$start" -v b="$EPOCHREALTIME" 'BEGIN { printf "%.3f", b - a }')
+        log "ready after ${ready}s"
+        next=0
+    fi
+    if [ $SECONDS -ge $next ]; then
+        write_metrics
+        next=$((SECONDS + METRICS_INTERVAL))
+    fi
+    # 就绪之前每0.1秒检查一次，之后只需要按METRICS_INTERVAL刷新
+    if [ -z "$ready" ]; then sleep 0.1; else sleep 1; fi
+done
+wait $child
@@ -0,0 +1,102 @@
+#!/bin/bash
+# qemu-fastdisk：一次性运行用的磁盘配置，用法同qemu-system-riscv64
+#   把-drive里的磁盘镜像复制到tmpfs上，再加上aio=XV6_DISK_AIO和cache=XV6_DISK_CACHE启动QEMU，
+#   退出后删除副本。guest的写入不会写回原来的fs.img，适合评测、跑测试这类不需要保留磁盘内容的场景
+#   在实验目录下：make qemu QEMU=qemu-fastdisk，或者QEMU=qemu-fastdisk xv6-run ...
+# 环境变量：
+#   XV6_DISK_AIO    io_uring（默认）、threads或native（native要求cache.direct=on，和cache=unsafe不能同时用）
+#   XV6_DISK_CACHE  默认unsafe，忽略guest的flush请求，宿主机写入全部异步
+#   XV6_DISK_DIR    镜像副本放在哪个目录，默认/dev/shm。Docker默认只给/dev/shm 64M，fs实验的fs.img（FSSIZE 200000）
+#                   约200M放不下，需要docker run --shm-size=512m，或者指向更大的tmpfs；
+#                   空间不够时给出警告，副本改放到TMPDIR（默认/tmp）下
+#   XV6_DISK_AIO_FALLBACK  io_uring不可用时改用的后端，默认threads，设为空时直接报错退出
+# Docker 25之后默认的seccomp配置禁止了io_uring_*系统调用，QEMU会打不开磁盘，所以启动前先试一下，
+# 不可用时给出警告并退回threads。要用io_uring需要docker run --security-opt seccomp=unconfined，
+# 或者在默认配置的基础上放开io_uring_setup、io_uring_enter、io_uring_register的自定义配置文件
+
+set -euo pipefail
+
+XV6_DISK_AIO=${XV6_DISK_AIO:-io_uring}
+XV6_DISK_CACHE=${XV6_DISK_CACHE:-unsafe}
+XV6_DISK_DIR=${XV6_DISK_DIR:-/dev/shm}
+XV6_DISK_AIO_FALLBACK=${XV6_DISK_AIO_FALLBACK-threads}
+
+tmp=$(mktemp -d "$XV6_DISK_DIR/xv6-disk.XXXXXX")
+spill=
+qemu_pid=
+trap '[ -n "$qemu_pid" ] && kill $qemu_pid 2>/dev/null; rm -rf "$tmp" ${spill:+"$spill"}' EXIT
+trap 'exit 143' TERM
+trap 'exit 130' INT
+
+# 用一个不带机器的QEMU打开1M的空镜像，能打开说明io_uring可用，monitor收到quit后退出
+io_uring_works() {
+    truncate -s 1M "$tmp/probe.img"
+    printf 'quit\n' | qemu-system-riscv64 -nodefaults -machine none -display none -monitor stdio \
+        -drive "file=$tmp/probe.img,if=none,format=raw,aio=io_uring,cache=$XV6_DISK_CACHE" >/dev/null 2>&1
+    local rc=$?
+    rm -f "$tmp/probe.img"
+    return $rc
+}
+
+if [ "$XV6_DISK_AIO" = io_uring ] && ! io_uring_works; then
+    if [ -z "$XV6_DISK_AIO_FALLBACK" ]; then
+        echo "qemu-fastdisk: io_uring is not available (blocked by seccomp?)" >&2
+        exit 1
+    fi
+    echo "qemu-fastdisk: io_uring is not available (blocked by seccomp?), using aio=$XV6_DISK_AIO_FALLBACK" >&2
+    XV6_DISK_AIO=$XV6_DISK_AIO_FALLBACK
+fi
+
+# 把镜像复制到tmpfs上，副本路径放在copied里；tmpfs剩余空间不够时改放到TMPDIR下
+copy_image() {
+    local file=$1 dir=$tmp size avail
+    size=$(stat -c %s "$file")
+    avail=$(df --output=avail -B1 "$tmp" | tail -1)
+    if [ "$size" -ge "$avail" ]; then
+        [ -n "$spill" ] || spill=$(mktemp -d "${TMPDIR:-/tmp}/xv6-disk.XXXXXX")
+        echo "qemu-fastdisk: $file ($((size >> 20))M) does not fit in $XV6_DISK_DIR ($((avail >> 20))M free)," \
+            "copying it to $spill instead; use docker run --shm-size=... or XV6_DISK_DIR=<a larger tmpfs>" >&2
+        dir=$spill
+    fi
+    cp "$file" "$dir/"
+    copied=$dir/$(basename "$file")
+}
+
+# 改写-drive的参数，结果放在drive_opts里：file换成副本，去掉原来的aio和cache。
+# 复制要在主shell里做，放在$(...)里的话set -e不起作用，复制失败也会照常启动QEMU
+drive() {
+    local opt opts=() parts
+    IFS=, read -r -a parts <<<"$1"
+    for opt in "${parts[@]}"; do
+        case $opt in
+        file=*)
+            copy_image "${opt#file=}"
+            opts+=("file=$copied")
+            ;;
+        aio=* | cache=*) ;;
+        *) opts+=("$opt") ;;
+        esac
+    done
+    opts+=("aio=$XV6_DISK_AIO" "cache=$XV6_DISK_CACHE")
+    drive_opts=$(IFS=,; echo "${opts[*]}")
+}
+
+args=()
+while [ $# -gt 0 ]; do
+    if [ "$1" = -drive ] && [ $# -gt 1 ]; then
+        drive "$2"
+        args+=(-drive "$drive_opts")
+        shift 2
+    else
+        args+=("$1")
+        shift
+    fi
+done
+
+# 不能直接exec，QEMU退出后还要删掉副本
+qemu-system-riscv64 "${args[@]}" <&0 &
+qemu_pid=$!
+rc=0
+wait $qemu_pid || rc=$?
+qemu_pid=
+exit $rc
@@ -0,0 +1,12 @@
+#!/bin/bash
+# qemu-guest-cgroup：默认镜像里装成/usr/local/sbin/qemu-system-riscv64，在PATH里排在真正的QEMU前面
+# 先把自己挪进container-supervisor建好的guests cgroup，再exec真正的QEMU，这样guest内存从第一页起就记在guests上。
+# cgroup v2迁移进程时不会迁移已有的内存计费，等supervisor定期挪就晚了：xv6的kinit第一秒就把128M内存全部写一遍，
+# 会一直算在editor头上
+# 没有启用cgroup限制时（guests不存在）什么也不做
+
+procs=/sys/fs/cgroup/guests/cgroup.procs
+if [ -e "$procs" ]; then
+    { echo $$ >"$procs"; } 2>/dev/null || echo $$ | sudo -n tee "$procs" >/dev/null 2>&1
+fi
+exec /usr/local/bin/qemu-system-riscv64 "$@"
@@ -0,0 +1,7 @@
+#!/bin/bash
+# qemu-mttcg：以多线程TCG（MTTCG）方式运行qemu-system-riscv64，每个hart对应一个宿主机线程
+# QEMU 5.1的configure给riscv64打开了mttcg，在x86宿主机上默认就是多线程TCG；这里显式指定，
+# 换了QEMU版本或宿主机时也不会悄悄退回单线程。对比单线程时用-accel tcg,thread=single
+# 用法同qemu-system-riscv64，在实验目录下：make qemu QEMU=qemu-mttcg CPUS=4
+
+exec qemu-system-riscv64 -accel tcg,thread=multi "$@"
@@ -0,0 +1,128 @@
+#!/bin/bash
+# qemu-pgo-build：以LTO + PGO方式编译QEMU，需要在QEMU源码目录下运行
+#   1.编译一个普通的-O2版本作为对照组
+#   2.编译带-fprofile-generate插桩的版本，用它启动xv6并跑一遍训练负载（默认usertests）
+#   3.用训练得到的profile重新编译（-fprofile-use），安装到DESTDIR
+#   4.对照组和PGO版本各跑PGO_BENCH_RUNS次相同负载，生成耗时报告
+# 启动阶段几乎都在做TCG翻译，负载阶段主要是执行翻译好的代码，报告里分开统计
+#
+# 用法：qemu-pgo-build <destdir> <configure参数...>
+# 环境变量：
+#   QEMU_MARCH      传给gcc的-march，默认native（镜像只能在同代CPU上运行）
+#   XV6_REPO        训练用的xv6仓库，默认git://g.csail.mit.edu/xv6-labs-2020
+#   XV6_BRANCH      训练用的xv6分支，默认util
+#   PGO_WORKLOAD    训练和计时用的guest命令，空格分隔，默认usertests
+#   PGO_CHECK       负载输出中必须出现的字符串，默认"ALL TESTS PASSED"
+#   PGO_BENCH_RUNS  计时重复次数，取中位数，默认3
+#   PGO_TIMEOUT     每次运行负载的超时秒数，默认3600。插桩版本（-fprofile-update=atomic）比普通版本慢好几倍，
+#                   超时会让整个docker build失败
+
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+    sed -n '9,19s/^# \{0,1\}//p' "$0" >&2
+    exit 2
+fi
+destdir=$1
+shift
+
+QEMU_MARCH=${QEMU_MARCH:-native}
+XV6_REPO=${XV6_REPO:-git://g.csail.mit.edu/xv6-labs-2020}
+XV6_BRANCH=${XV6_BRANCH:-util}
+PGO_WORKLOAD=${PGO_WORKLOAD:-usertests}
+PGO_CHECK=${PGO_CHECK:-ALL TESTS PASSED}
+PGO_BENCH_RUNS=${PGO_BENCH_RUNS:-3}
+PGO_TIMEOUT=${PGO_TIMEOUT:-3600}
+
+src=$PWD
+work=$(mktemp -d /tmp/qemu-pgo.XXXXXX)
+jobs=$(nproc)
+profile_dir=$work/profile
+read -r -a workload <<<"$PGO_WORKLOAD"
+
+# 1.准备训练用的xv6内核和fs.img
+git clone --depth 1 -b "$XV6_BRANCH" "$XV6_REPO" "$work/xv6"
+make -C "$work/xv6" -j"$jobs" kernel/kernel fs.img
+
+# 在build目录中配置并编译QEMU，$1是build目录，$2是CFLAGS，$3是LDFLAGS，其余是configure参数
+build_qemu() {
+    local dir=$1 cflags=$2 ldflags=$3
+    shift 3
+    mkdir -p "$dir"
+    (cd "$dir" && AR=gcc-ar NM=gcc-nm "$src/configure" "$@" \
+        --extra-cflags="$cflags" --extra-ldflags="$ldflags" && \
+        make -j"$jobs")
+}
+
+# build目录里编译出的qemu-system-riscv64，5.2之后改用meson，不再放在riscv64-softmmu子目录下
+qemu_bin() {
+    if [ -x "$1/qemu-system-riscv64" ]; then
+        echo "$1/qemu-system-riscv64"
+    else
+        echo "$1/riscv64-softmmu/qemu-system-riscv64"
+    fi
+}
+
+# 用指定的QEMU跑一遍负载，输出"启动秒数 负载秒数"
+run_workload() {
+    local qemu=$1 log=$work/run.log timings=$work/run.timings
+    QEMU=$qemu xv6-run -s -t "$PGO_TIMEOUT" -k "$work/xv6/kernel/kernel" -f "$work/xv6/fs.img" \
+        -l "$log" -T "$timings" "${workload[@]}"
+    if ! grep -q "$PGO_CHECK" "$log"; then
+        echo "qemu-pgo-build: '$PGO_CHECK' not found in guest output:" >&2
+        tail -20 "$log" >&2
+        return 1
+    fi
+    awk -F'\t' '$1 == "boot" { b = $2 } $1 == "cmd" { c += $2 } END { print b, c }' "$timings"
+}
+
+# 跑PGO_BENCH_RUNS次，输出启动、负载、合计三项的中位数
+bench() {
+    local i out=$work/bench.txt
+    : >"$out"
+    for ((i = 0; i < PGO_BENCH_RUNS; i++)); do
+        run_workload "$1" >>"$out" || return 1
+    done
+    awk '{ b[NR] = $1; c[NR] = $2; t[NR] = $1 + $2 }
+        function median(a, n,   i, j, x) {
+            for (i = 2; i <= n; i++) { x = a[i]; for (j = i - 1; j > 0 && a[j] > x; j--) a[j + 1] = a[j]; a[j + 1] = x }
+            return n % 2 ? a[(n + 1) / 2] : (a[n / 2] + a[n / 2 + 1]) / 2
+        }
+        END { printf "%.3f %.3f %.3f\n", median(b, NR), median(c, NR), median(t, NR) }' "$out"
+}
+
+opt="-O2 -march=$QEMU_MARCH"
+lto="-flto=$jobs -fuse-linker-plugin"
+
+# 2.对照组：普通-O2编译
+build_qemu "$work/build-base" "-O2" "" "$@"
+# 3.插桩编译并训练；QEMU是多线程的，计数器要用原子更新
+build_qemu "$src/build-pgo" "$opt $lto -fprofile-generate=$profile_dir -fprofile-update=atomic" \
+    "$lto -fprofile-generate=$profile_dir" "$@"
+run_workload "$(qemu_bin "$src/build-pgo")" >/dev/null
+# 4.在同一个build目录里用profile重新编译，保证.gcda和目标文件的路径对得上
+make -C "$src/build-pgo" clean
+build_qemu "$src/build-pgo" "$opt $lto -fprofile-use=$profile_dir -fprofile-correction -Wno-missing-profile" \
+    "$lto -fprofile-use=$profile_dir" "$@"
+make -C "$src/build-pgo" install DESTDIR="$destdir"
+
+# 5.生成耗时报告
+base=$(bench "$(qemu_bin "$work/build-base")")
+pgo=$(bench "$(qemu_bin "$src/build-pgo")")
+read -r base_boot base_work base_total <<<"$base"
+read -r pgo_boot pgo_work pgo_total <<<"$pgo"
+report=$destdir/usr/local/share/qemu/pgo-report.txt
+mkdir -p "$(dirname "$report")"
+{
+    echo "QEMU $(cat "$src/VERSION") riscv64-softmmu LTO+PGO timing report"
+    echo "march=$QEMU_MARCH workload='$PGO_WORKLOAD' xv6=$XV6_BRANCH runs=$PGO_BENCH_RUNS (median seconds)"
+    echo
+    printf '%-10s %12s %12s %12s\n' "" "boot" "workload" "total"
+    printf '%-10s %12s %12s %12s\n' baseline "$base_boot" "$base_work" "$base_total"
+    printf '%-10s %12s %12s %12s\n' lto+pgo "$pgo_boot" "$pgo_work" "$pgo_total"
+    awk -v b1="$base_boot" -v b2="$base_work" -v b3="$base_total" \
+        -v p1="$pgo_boot" -v p2="$pgo_work" -v p3="$pgo_total" \
+        'BEGIN { printf "%-10s %11.2fx %11.2fx %11.2fx\n", "speedup", b1 / p1, b2 / p2, b3 / p3 }'
+} | tee "$report"
+
+rm -rf "$work"
@@ -0,0 +1,48 @@
+#!/bin/bash
+# xv6-addprog：把当前实验目录复制到目标目录，加入额外的用户程序后编译kernel/kernel和fs.img，实验目录本身不受影响
+# xv6-smp-bench、xv6-disk-bench用它把测试负载编译进xv6
+#
+# 用法：在实验目录下执行 xv6-addprog [-D NAME=VALUE]... <目标目录> <prog.c>...
+#   -D      修改副本kernel/param.h里的#define，例如 -D FSSIZE=4000
+#   prog.c  用户程序的源码，不带路径时在/usr/local/share/xv6下找，程序名就是文件名去掉.c
+# 编译失败时打印编译输出的最后20行并返回1，完整输出在<目标目录>/build.log
+
+set -euo pipefail
+
+defines=()
+while getopts "D:" opt; do
+    case $opt in
+    D) defines+=("$OPTARG") ;;
+    *) sed -n '5,8s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+if [ $# -lt 2 ]; then
+    sed -n '5,8s/^# \{0,1\}//p' "$0" >&2
+    exit 2
+fi
+dst=$1
+shift
+
+rsync -a --exclude .git ./ "$dst/"
+for def in "${defines[@]}"; do
+    grep -q "^#define ${def%%=*}[[:space:]]" "$dst/kernel/param.h" || {
+        echo "xv6-addprog: ${def%%=*} is not defined in kernel/param.h" >&2
+        exit 1
+    }
+    sed -i "s|^#define ${def%%=*}[[:space:]].*|#define ${def%%=*} ${def#*=}|" "$dst/kernel/param.h"
+done
+for src in "$@"; do
+    [[ $src == */* ]] || src=/usr/local/share/xv6/$src
+    prog=$(basename "$src" .c)
+    cp "$src" "$dst/user/"
+    grep -q "_$prog\\b" "$dst/Makefile" ||
+        sed -i "s|^UPROGS=\\\\\$|UPROGS=\\\\\\n\\t\$U/_$prog\\\\|" "$dst/Makefile"
+done
+# 从实验目录带过来的fs.img里没有新程序，删掉让make重新生成
+rm -f "$dst/fs.img"
+make -C "$dst" -j"$(nproc)" kernel/kernel fs.img >"$dst/build.log" 2>&1 || {
+    echo "xv6-addprog: build failed:" >&2
+    tail -20 "$dst/build.log" >&2
+    exit 1
+}
@@ -0,0 +1,114 @@
+#!/bin/bash
+# xv6-batch：批量评测，同时运行多个互相隔离的xv6 guest
+#   每个guest的磁盘是以对应fs.img为backing file的qcow2 overlay，写入互不影响，原来的fs.img不会被修改；
+#   每个并发槽位有自己的gdb端口（GDB_PORT + 槽位号）和自己的一组宿主机CPU（taskset绑定），
+#   任务从一个共享队列里领取，跑得快的槽位会多领，最后汇总每个任务的结果和耗时
+#
+# 用法：xv6-batch [-j jobs] [-C cores] [-c cpus] [-t timeout] [-p regex] [-g port] [-o outdir] jobfile
+#   -j  同时运行的guest数量，默认 宿主机核数/cores
+#   -C  每个guest绑定的宿主机核数，默认1；用qemu-mttcg时一般和-c相同
+#   -c  每个guest的hart数量，默认1
+#   -t  每个任务的超时秒数，默认600
+#   -p  判定通过的正则（grep -E），默认"ALL TESTS PASSED"
+#   -g  第一个槽位的gdb端口，默认26000
+#   -o  输出目录，默认./xv6-batch-out，每个任务的串口输出在<任务名>.log里
+#   jobfile每行一个任务："任务名 实验目录 guest命令"，实验目录下需要有编译好的kernel/kernel和fs.img，
+#   guest命令是这一行剩下的部分，作为一整行交给xv6的sh执行，#开头的行会被忽略
+# 环境变量：QEMU（同xv6-run）
+
+set -euo pipefail
+
+cores=1
+cpus=1
+timeout=600
+pass='ALL TESTS PASSED'
+gdb_base=26000
+out=xv6-batch-out
+jobs=
+
+while getopts "j:C:c:t:p:g:o:" opt; do
+    case $opt in
+    j) jobs=$OPTARG ;;
+    C) cores=$OPTARG ;;
+    c) cpus=$OPTARG ;;
+    t) timeout=$OPTARG ;;
+    p) pass=$OPTARG ;;
+    g) gdb_base=$OPTARG ;;
+    o) out=$OPTARG ;;
+    *) sed -n '7,17s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+if [ $# -ne 1 ]; then
+    sed -n '7,17s/^# \{0,1\}//p' "$0" >&2
+    exit 2
+fi
+
+host_cpus=$(nproc)
+jobs=${jobs:-$((host_cpus / cores > 0 ? host_cpus / cores : 1))}
+mapfile -t tasks < <(grep -v -e '^[[:space:]]*#' -e '^[[:space:]]*$' "$1")
+mkdir -p "$out"
+: >"$out/results.tsv"
+echo 0 >"$out/.next"
+
+# 从队列里领下一个任务的下标，队列空了返回1
+next_task() {
+    local i
+    exec 8<>"$out/.next"
+    flock 8
+    read -r i <"$out/.next"
+    echo $((i + 1)) >"$out/.next"
+    exec 8>&-
+    [ "$i" -lt ${#tasks[@]} ] && echo "$i"
+}
+
+run_task() {
+    local slot=$1 name dir cmd c mask overlay rc status start wall
+    read -r name dir cmd <<<"${tasks[$2]}"
+    # 槽位slot固定使用第slot*cores个开始的cores个宿主机核，核不够时循环使用
+    mask=
+    for ((c = slot * cores; c < (slot + 1) * cores && c < slot * cores + host_cpus; c++)); do
+        mask+=${mask:+,}$((c % host_cpus))
+    done
+    overlay=$out/$name.qcow2
+    start=$EPOCHREALTIME
+    rc=0
+    qemu-img create -q -f qcow2 -F raw -b "$(realpath "$dir/fs.img")" "$overlay" &&
+        taskset -c "$mask" xv6-run -k "$dir/kernel/kernel" -f "$overlay" -c "$cpus" -t "$timeout" \
+            -g $((gdb_base + slot)) -l "$out/$name.log" -T "$out/$name.timings" "$cmd" || rc=$?
+    wall=$(awk -v a="$start" -v b="$EPOCHREALTIME" 'BEGIN { printf "%.3f", b - a }')
+    if [ $rc -ne 0 ]; then
+        status=ERROR
+    elif grep -Eq -- "$pass" "$out/$name.log"; then
+        status=PASS
+    else
+        status=FAIL
+    fi
+    rm -f "$overlay"
+    printf '%s\t%s\t%s\t%s\n' "$name" "$status" "$wall" "$mask" >>"$out/results.tsv"
+    printf '%-20s %-5s %8ss  cpus %s\n' "$name" "$status" "$wall" "$mask"
+}
+
+worker() {
+    local i
+    while i=$(next_task); do
+        run_task "$1" "$i"
+    done
+}
+
+start=$EPOCHREALTIME
+for ((slot = 0; slot < jobs; slot++)); do
+    worker "$slot" &
+done
+wait
+rm -f "$out/.next"
+
+awk -F'\t' -v a="$start" -v b="$EPOCHREALTIME" -v j="$jobs" '
+    { n++; s[$2]++; busy += $3 }
+    END {
+        wall = b - a
+        printf "\n%d tasks, %d passed, %d failed, %d errors, %d guests in parallel\n", n, s["PASS"], s["FAIL"], s["ERROR"], j
+        if (n > 0)
+            printf "wall %.1fs, %.1f tasks/min, average parallelism %.2f\n", wall, n * 60 / wall, busy / wall
+    }' "$out/results.tsv"
+! grep -qv "$(printf '\tPASS\t')" "$out/results.tsv"
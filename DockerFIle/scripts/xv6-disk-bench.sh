@@ -0,0 +1,86 @@
+#!/bin/bash
+# xv6-disk-bench：在guest里跑文件系统负载，对比不同磁盘后端配置的吞吐和延迟
+# 把实验目录复制到临时目录，加入fsbench用户程序后编译kernel/kernel和fs.img，再依次用下面几种配置运行：
+#   default   QEMU默认配置（aio=threads，cache=writeback），镜像在普通磁盘上
+#   threads   qemu-fastdisk，aio=threads，cache=unsafe，镜像在tmpfs上
+#   io_uring  qemu-fastdisk，aio=io_uring，cache=unsafe，镜像在tmpfs上
+# 每种配置都从同一份干净的fs.img开始，依次执行fsbench write、read、create，耗时由xv6-run在宿主机上统计。
+# 每条命令的耗时还包含exec、串口输出和提示符往返，所以先跑一次什么都不做的fsbench create 0，
+# 表里的时间都减去这部分固定开销，再按KB或文件数平均
+# 默认fs.img只有1000块，装完用户程序后剩下的空闲块不够写测试文件（用完时balloc会panic），
+# 副本里的FSSIZE会按files和blocks加大
+#
+# 用法：在实验目录下执行 xv6-disk-bench [-n files] [-b blocks] [-m creates] [-c "default threads io_uring"]
+#   -n  写/读的文件数，默认 2
+#   -b  每个文件的块数（1KB），默认 200，不能超过268（xv6的MAXFILE）
+#   -m  create测试创建再删除的文件数，默认 50
+#   -c  要测试的配置，默认 "default threads io_uring"
+
+set -euo pipefail
+
+files=2
+blocks=200
+creates=50
+configs="default threads io_uring"
+
+while getopts "n:b:m:c:" opt; do
+    case $opt in
+    n) files=$OPTARG ;;
+    b) blocks=$OPTARG ;;
+    m) creates=$OPTARG ;;
+    c) configs=$OPTARG ;;
+    *) sed -n '13,17s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# 1. 在副本里加入fsbench，不改动实验目录
+# 超过12块的文件还要一个间接块，多留64块给create测试和bitmap的增长
+fssize=$(awk '$1 == "#define" && $2 == "FSSIZE" { print $3 }' kernel/param.h)
+xv6-addprog -D FSSIZE=$((fssize + files * (blocks + 1) + 64)) "$work/src" fsbench.c
+
+# 2. 依次运行各个配置
+run() {
+    local config=$1
+    cp "$work/src/fs.img" "$work/fs.img"
+    case $config in
+    default) env QEMU=qemu-system-riscv64 "${@:2}" ;;
+    # 不让qemu-fastdisk退回threads，否则io_uring一栏测的其实是threads
+    threads | io_uring) env QEMU=qemu-fastdisk XV6_DISK_AIO="$config" XV6_DISK_AIO_FALLBACK= "${@:2}" ;;
+    *) echo "xv6-disk-bench: unknown config '$config'" >&2; return 1 ;;
+    esac
+}
+
+kb=$((files * blocks))
+rc=0
+echo "fsbench: write/read $files x $blocks KB, create+unlink $creates files"
+echo "times exclude the exec + prompt round trip measured with an empty fsbench run"
+printf '%-10s %12s %12s %12s %12s %14s\n' config write\(KB/s\) write\ ms/KB read\(KB/s\) read\ ms/KB ms/create
+for config in $configs; do
+    if ! run "$config" xv6-run -k "$work/src/kernel/kernel" -f "$work/fs.img" -l "$work/log.$config" \
+        -T "$work/timings.$config" "fsbench create 0" "fsbench write $files $blocks" \
+        "fsbench read $files $blocks" "fsbench create $creates" 2>>"$work/log.$config" ||
+        [ "$(grep -c 'fsbench: ok' "$work/log.$config")" -ne 4 ]; then
+        # 一个配置失败不影响其他配置，io_uring被seccomp禁用时只标记为不可用
+        if grep -q 'io_uring is not available' "$work/log.$config"; then
+            printf '%-10s %s\n' "$config" "unavailable (io_uring blocked by seccomp, see qemu-fastdisk)"
+        else
+            printf '%-10s %s\n' "$config" failed
+            echo "xv6-disk-bench: $config failed, guest output:" >&2
+            tail -20 "$work/log.$config" >&2
+            rc=1
+        fi
+        continue
+    fi
+    awk -F'\t' -v config="$config" -v kb="$kb" -v creates="$creates" '
+        $1 == "cmd" { t[++n] = $2 }
+        END {
+            # t[1]是空跑的固定开销，减掉后至少留1ms，避免除以0
+            for (i = 2; i <= 4; i++) d[i] = t[i] - t[1] > 0.001 ? t[i] - t[1] : 0.001
+            printf "%-10s %12.0f %12.3f %12.0f %12.3f %14.3f\n", config,
+                kb / d[2], 1000 * d[2] / kb, kb / d[3], 1000 * d[3] / kb, 1000 * d[4] / creates
+        }' "$work/timings.$config"
+done
+exit $rc
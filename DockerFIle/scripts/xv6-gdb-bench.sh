@@ -0,0 +1,82 @@
+#!/bin/bash
+# xv6-gdb-bench：测量gdb通过gdbstub调试xv6时单步和continue的往返延迟，对比TCP和Unix socket两种连接方式
+#   stepi：连续单步N次，每次都是一个完整的"继续执行-停下-读寄存器"往返
+#   continue：在acquire上打断点后continue N次，xv6空闲时scheduler一直在拿锁，断点几乎立即命中
+# 内核ELF里有没有.gdb_index会影响gdb启动加载符号的耗时，也一并统计（用xv6-gdb qemu启动过一次就会加上）
+#
+# 用法：在实验目录下执行 xv6-gdb-bench [N]，N默认200，需要先编译好kernel/kernel和fs.img
+
+set -euo pipefail
+
+n=${1:-200}
+kernel=kernel/kernel
+work=$(mktemp -d)
+qemu_pid=
+trap '[ -n "$qemu_pid" ] && kill $qemu_pid 2>/dev/null; rm -rf "$work"' EXIT
+
+cat >"$work/bench.py" <<'PY'
+import gdb, time
+
+n = int(gdb.convenience_variable("bench_n"))
+
+def mean_ms(cmd, count):
+    start = time.perf_counter()
+    for _ in range(count):
+        gdb.execute(cmd, to_string=True)
+    return (time.perf_counter() - start) * 1000 / count
+
+gdb.execute("break scheduler", to_string=True)
+gdb.execute("continue", to_string=True)
+gdb.execute("delete", to_string=True)
+step = mean_ms("stepi", n)
+gdb.execute("break acquire", to_string=True)
+cont = mean_ms("continue", n)
+print("RESULT %.3f %.3f" % (step, cont))
+PY
+
+# $1是-gdb参数，$2是gdb的target remote地址，输出"连接秒数 stepi毫秒 continue毫秒"
+bench() {
+    local start out
+    qemu-system-riscv64 -machine virt -bios none -kernel "$kernel" -m 128M -smp 1 \
+        -display none -serial null -monitor none \
+        -drive file=fs.img,if=none,format=raw,id=x0,snapshot=on \
+        -device virtio-blk-device,drive=x0,bus=virtio-mmio-bus.0 -S -gdb "$1" &
+    qemu_pid=$!
+    sleep 0.5
+    start=$EPOCHREALTIME
+    out=$(gdb-multiarch -batch -nx \
+        -iex "set architecture riscv:rv64" \
+        -iex "set riscv use-compressed-breakpoints yes" \
+        -iex "set \$bench_n = $n" \
+        -ex "target remote $2" \
+        -x "$work/bench.py" "$kernel" 2>&1)
+    kill $qemu_pid 2>/dev/null
+    wait $qemu_pid 2>/dev/null || true
+    qemu_pid=
+    if ! grep -q '^RESULT ' <<<"$out"; then
+        echo "xv6-gdb-bench: gdb session over $2 failed:" >&2
+        echo "$out" >&2
+        exit 1
+    fi
+    awk -v a="$start" -v b="$EPOCHREALTIME" '/^RESULT / { printf "%8.3f %10.3f %10.3f\n", b - a, $2, $3 }' <<<"$out"
+}
+
+# 不带.gdb_index时gdb加载符号的耗时，和带索引时对比
+load_time() {
+    local start=$EPOCHREALTIME
+    gdb-multiarch -batch -nx -ex "info line main" "$1" >/dev/null
+    awk -v a="$start" -v b="$EPOCHREALTIME" 'BEGIN { printf "%.3f", b - a }'
+}
+
+if riscv64-linux-gnu-objdump -h "$kernel" | grep -q '\.gdb_index'; then
+    riscv64-linux-gnu-objcopy --remove-section .gdb_index "$kernel" "$work/kernel.noindex"
+    echo "symbol load: $(load_time "$work/kernel.noindex")s without .gdb_index, $(load_time "$kernel")s with"
+else
+    echo "symbol load: $(load_time "$kernel")s ($kernel has no .gdb_index, run xv6-gdb qemu once to add it)"
+fi
+
+echo "gdb round trips, mean of $n (session seconds include $n stepi + $n continue)"
+printf '%-6s %8s %10s %10s\n' "" session stepi\(ms\) cont\(ms\)
+port=$((26000 + $(id -u) % 5000))
+printf '%-6s %s\n' tcp "$(bench "tcp::$port" "127.0.0.1:$port")"
+printf '%-6s %s\n' unix "$(bench "unix:$work/gdb.sock,server,nowait" "$work/gdb.sock")"
@@ -0,0 +1,45 @@
+#!/bin/bash
+# xv6-gdb：低延迟的gdb调试配置，代替make qemu-gdb加上.gdbinit的TCP方式
+#   1.QEMU的gdbstub改为监听Unix socket，gdb通过本地socket连接，省掉TCP协议栈的往返开销
+#   2.给kernel/kernel加上.gdb_index，gdb加载符号时不用再扫描整份DWARF
+#   3.gdb不读实验目录下的.gdbinit（那份是连TCP端口的），改用下面等价的设置
+#
+# 用法（在实验目录下）：
+#   xv6-gdb qemu [make参数...]   编译并以-S方式启动QEMU，等待gdb连接，例如 xv6-gdb qemu CPUS=1
+#   xv6-gdb [gdb参数...]         在另一个终端里启动gdb-multiarch并连上QEMU
+# 环境变量：XV6_GDB_SOCKET，默认/tmp/xv6-gdb-<uid>-<实验目录名>.sock
+
+set -euo pipefail
+
+XV6_GDB_SOCKET=${XV6_GDB_SOCKET:-/tmp/xv6-gdb-$(id -u)-$(basename "$PWD").sock}
+kernel=kernel/kernel
+
+# 给内核ELF加上.gdb_index，已经有了就跳过（重新编译内核后会再加一次）
+add_gdb_index() {
+    local tmp
+    riscv64-linux-gnu-objdump -h "$kernel" | grep -q '\.gdb_index' && return 0
+    tmp=$(mktemp -d)
+    gdb-multiarch -batch -nx -ex "save gdb-index $tmp" "$kernel" >/dev/null
+    riscv64-linux-gnu-objcopy --add-section .gdb_index="$tmp/$(basename "$kernel").gdb-index" \
+        --set-section-flags .gdb_index=readonly "$kernel"
+    rm -rf "$tmp"
+}
+
+if [ "${1:-}" = qemu ]; then
+    shift
+    make "$kernel" fs.img "$@"
+    add_gdb_index
+    rm -f "$XV6_GDB_SOCKET"
+    exec make qemu-gdb QEMUGDB="-gdb unix:$XV6_GDB_SOCKET,server,nowait" "$@"
+fi
+
+# 与xv6的.gdbinit.tmpl-riscv相同，只是连接方式换成了Unix socket，
+# gdb会根据路径是socket文件自动使用Unix socket连接
+exec gdb-multiarch -q -nx \
+    -iex "set confirm off" \
+    -iex "set pagination off" \
+    -iex "set architecture riscv:rv64" \
+    -iex "set riscv use-compressed-breakpoints yes" \
+    -ex "target remote $XV6_GDB_SOCKET" \
+    -ex "set disassemble-next-line auto" \
+    "$@" "$kernel"
@@ -0,0 +1,89 @@
+#!/bin/bash
+# xv6-profile：用tbcount插件统计guest里每个翻译块的执行次数，按内核符号汇总成热点列表和火焰图
+#   每个TB的权重是"执行次数 x 指令数"，即执行的guest指令数；
+#   0x80000000以上按内核ELF的符号表归到函数，trampoline页（MAXVA - PGSIZE）映射回kernel里的uservec/userret，
+#   其余地址是用户程序（所有用户程序都从0开始链接，无法区分具体是哪个），统一归为[user]
+#
+# 用法：xv6-profile [-k kernel] [-f fs.img] [-c cpus] [-n top] [-o prefix] [--] cmd...
+#   -k、-f、-c  同xv6-run，磁盘以snapshot=on方式挂载
+#   -n          热点列表显示的函数个数，默认30
+#   -o          输出文件前缀，默认xv6-profile，生成：
+#                 <prefix>.tb      插件输出的原始数据
+#                 <prefix>.folded  火焰图的折叠栈格式，可以交给flamegraph.pl或speedscope
+#                 <prefix>.svg     PATH里有flamegraph.pl时生成
+# 例如：xv6-profile usertests
+
+set -euo pipefail
+
+PLUGIN=${XV6_TBCOUNT_PLUGIN:-/usr/local/lib/qemu-plugins/libtbcount.so}
+kernel=kernel/kernel
+fs=fs.img
+cpus=3
+top=30
+prefix=xv6-profile
+
+while getopts "k:f:c:n:o:" opt; do
+    case $opt in
+    k) kernel=$OPTARG ;;
+    f) fs=$OPTARG ;;
+    c) cpus=$OPTARG ;;
+    n) top=$OPTARG ;;
+    o) prefix=$OPTARG ;;
+    *) sed -n '7,15s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+rm -f "$prefix.tb"
+QEMUEXTRA="${QEMUEXTRA:-} -plugin $PLUGIN,arg=$(realpath "$prefix").tb" \
+    xv6-run -s -k "$kernel" -f "$fs" -c "$cpus" "$@"
+
+# 第一遍读nm输出的函数符号（已按地址排序），第二遍对每个TB二分查找所属的函数；
+# Ubuntu默认的awk是mawk，没有strtonum，十六进制地址自己转换
+riscv64-linux-gnu-nm -n --defined-only "$kernel" | awk '
+    function hex(s,   i, v) {
+        v = 0
+        for (i = 1; i <= length(s); i++) v = v * 16 + index("0123456789abcdef", substr(tolower(s), i, 1)) - 1
+        return v
+    }
+    NR == FNR {
+        if ($2 ~ /^[tTwW]$/) { addr[n] = hex($1); name[n] = $3; n++ }
+        if ($3 == "trampoline") trampoline = hex($1)
+        next
+    }
+    function lookup(pc,   lo, hi, mid) {
+        if (n == 0 || pc < addr[0]) return "??"
+        lo = 0; hi = n - 1
+        while (lo < hi) {
+            mid = int((lo + hi + 1) / 2)
+            if (addr[mid] <= pc) lo = mid; else hi = mid - 1
+        }
+        return name[lo]
+    }
+    {
+        pc = hex($1)
+        w = $2 * $3
+        if (pc >= 274877902848 && pc < 274877906944) {
+            # TRAMPOLINE = MAXVA - PGSIZE = 0x3ffffff000
+            stack = "trampoline;" lookup(pc - 274877902848 + trampoline)
+        } else if (pc >= 2147483648) {
+            stack = "kernel;" lookup(pc)
+        } else {
+            stack = "user;[user]"
+        }
+        folded[stack] += w
+    }
+    END { for (s in folded) printf "%s %.0f\n", s, folded[s] }
+' - "$prefix.tb" | sort >"$prefix.folded"
+
+total=$(awk '{ t += $2 } END { printf "%.0f", t }' "$prefix.folded")
+printf '\n%s guest instructions executed\n%7s %14s  %s\n' "$total" % insns symbol
+sort -k2,2nr "$prefix.folded" |
+    awk -v total="$total" -v top="$top" 'NR <= top { printf "%6.2f%% %14.0f  %s\n", 100 * $2 / total, $2, $1 }'
+
+if command -v flamegraph.pl >/dev/null; then
+    flamegraph.pl --title "xv6 guest: $*" --countname instructions "$prefix.folded" >"$prefix.svg"
+    echo "flame graph: $prefix.svg"
+else
+    echo "folded stacks: $prefix.folded (flamegraph.pl not found in PATH)"
+fi
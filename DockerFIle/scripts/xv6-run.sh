@@ -0,0 +1,212 @@
+#!/bin/bash
+# xv6-run：启动一个xv6 guest，等到shell提示符"$ "后逐条执行给定的命令，全部执行完后退出QEMU
+# guest的串口输出打印到标准输出（或-l指定的文件），各阶段耗时写到-T指定的文件里，方便脚本做统计
+#
+# 用法：xv6-run [-k kernel] [-f fs.img] [-c cpus] [-t timeout] [-l log] [-T timings] [-g port] [-s]
+#               [-S state | -R state] [--] [cmd...]
+#   -k  内核ELF，默认 ./kernel/kernel
+#   -f  磁盘镜像，默认 ./fs.img，以.qcow2结尾时按qcow2格式挂载（例如以fs.img为backing file的overlay）
+#   -c  hart数量，默认 3（与xv6 Makefile的CPUS一致）
+#   -t  超时秒数，默认 600，超时后杀掉QEMU并返回1
+#   -l  串口输出写到文件，默认标准输出
+#   -T  耗时统计写到文件，每行"boot<TAB>秒数<TAB>CPU秒数"或"cmd<TAB>秒数<TAB>CPU秒数<TAB>命令"，
+#       CPU秒数是这段时间内QEMU进程所有线程消耗的用户态+内核态时间，用了-S时还有一行"save<TAB>秒数"
+#   -g  在该TCP端口上打开gdbstub，guest照常运行，gdb可以随时连上来
+#   -s  以snapshot=on方式挂载磁盘，guest的写入不会落到fs.img上
+#   -S  命令都执行完后暂停guest，把整个虚拟机状态（内存、CPU、设备）保存到state文件
+#   -R  不启动内核，直接从-S保存的state文件恢复，此时-k、-c和磁盘内容都要与保存时一致
+# 环境变量：QEMU（默认qemu-system-riscv64），QEMUEXTRA（追加给QEMU的参数）
+
+set -u
+
+QEMU=${QEMU:-qemu-system-riscv64}
+kernel=kernel/kernel
+fs=fs.img
+cpus=3
+timeout=600
+log=/dev/stdout
+timings=/dev/null
+drive_opts=
+gdb_port=
+save=
+restore=
+
+while getopts "k:f:c:t:l:T:g:sS:R:" opt; do
+    case $opt in
+    k) kernel=$OPTARG ;;
+    f) fs=$OPTARG ;;
+    c) cpus=$OPTARG ;;
+    t) timeout=$OPTARG ;;
+    l) log=$OPTARG ;;
+    T) timings=$OPTARG ;;
+    g) gdb_port=$OPTARG ;;
+    s) drive_opts=,snapshot=on ;;
+    S) save=$OPTARG ;;
+    R) restore=$OPTARG ;;
+    *) sed -n '5,20s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+for f in "$kernel" "$fs"; do
+    [ -f "$f" ] || { echo "xv6-run: $f not found" >&2; exit 2; }
+done
+
+case $fs in
+*.qcow2) format=qcow2 ;;
+*) format=raw ;;
+esac
+
+# 与xv6 Makefile中的QEMUOPTS保持一致
+qemu_args=(-machine virt -bios none -kernel "$kernel" -m 128M -smp "$cpus" -nographic
+    -drive "file=$fs,if=none,format=$format,id=x0$drive_opts"
+    -device virtio-blk-device,drive=x0,bus=virtio-mmio-bus.0)
+[ -n "$gdb_port" ] && qemu_args+=(-gdb "tcp::$gdb_port")
+[ -n "$restore" ] && qemu_args+=(-incoming "exec:cat '$restore'")
+# shellcheck disable=SC2206
+qemu_args+=(${QEMUEXTRA:-})
+
+exec 3>"$log" 4>"$timings"
+
+clk_tck=$(getconf CLK_TCK)
+
+elapsed() {
+    awk -v a="$1" -v b="$EPOCHREALTIME" 'BEGIN { printf "%.3f", b - a }'
+}
+
+# QEMU进程目前为止消耗的CPU时间（utime + stime，单位是clock tick）
+cpu_ticks() {
+    local stat
+    read -r -a stat <"/proc/$guest_pid/stat" 2>/dev/null || { echo 0; return; }
+    echo $((stat[13] + stat[14]))
+}
+
+cpu_elapsed() {
+    awk -v a="$1" -v b="$(cpu_ticks)" -v hz="$clk_tck" 'BEGIN { printf "%.3f", (b - a) / hz }'
+}
+
+coproc GUEST { exec "$QEMU" "${qemu_args[@]}" 2>&1; }
+guest_pid=$GUEST_PID
+# coproc退出后bash会回收GUEST数组，先把管道复制到固定的fd上
+exec 5<&"${GUEST[0]}" 6>&"${GUEST[1]}"
+deadline=$((SECONDS + timeout))
+pending=
+
+# 读取guest输出直到出现提示符$1（默认是sh的"$ "，QEMU monitor是"(qemu) "），最多等到第$2秒；
+# 提示符后面没有换行，所以以提示符的最后一个字符为分隔符读取，提示符一到就能识别出来，
+# 不用等read超时。期间读到的完整行保存在output里，超时返回1，QEMU退出返回2
+wait_prompt() {
+    local prompt=${1:-'$ '} until=${2:-$deadline} chunk= rc
+    local delim=${prompt: -1}
+    output=
+    while [ $SECONDS -lt $until ]; do
+        IFS= read -r -d "$delim" -t 0.2 chunk <&5
+        rc=$?
+        if [ $rc -eq 0 ]; then
+            pending+=$chunk$delim
+        elif [ $rc -gt 128 ]; then
+            # 超时时bash会把已读到的部分留在变量里
+            pending+=$chunk
+        else
+            pending+=$chunk
+            [ -n "$pending" ] && printf '%s\n' "$pending" >&3
+            pending=
+            echo "xv6-run: qemu exited before the prompt" >&2
+            return 2
+        fi
+        if [[ $pending == *$'\n'* ]]; then
+            chunk=${pending%$'\n'*}
+            printf '%s\n' "$chunk" >&3
+            output+=$chunk$'\n'
+            pending=${pending##*$'\n'}
+        fi
+        # 提示符之后guest会停下来等输入，紧接着还有输出说明只是行中间碰巧出现了"$ "
+        if [ $rc -eq 0 ] && [[ $pending == *"$prompt" ]] && ! read -r -t 0 <&5; then
+            printf '%s' "$pending" >&3
+            pending=
+            return 0
+        fi
+    done
+    [ $until -ge $deadline ] && echo "xv6-run: timed out after ${timeout}s" >&2
+    return 1
+}
+
+# 通过QEMU monitor执行一条命令
+monitor() {
+    printf '%s\n' "$1" >&6
+    wait_prompt '(qemu) '
+}
+
+# 把虚拟机状态迁移到文件里，guest在shell提示符处空闲时保存，恢复后就停在同一个地方
+save_state() {
+    # Ctrl-A c切换到monitor
+    printf '\001c' >&6
+    wait_prompt '(qemu) ' || return 1
+    monitor stop || return 1
+    # 默认的迁移带宽上限是32MB/s，本地文件不需要限速
+    monitor 'migrate_set_parameter max-bandwidth 100G' || return 1
+    monitor "migrate \"exec:cat > '$save'\"" || return 1
+    while monitor 'info migrate'; do
+        case $output in
+        *'Migration status: completed'*) return 0 ;;
+        *'Migration status: failed'* | *'Migration status: cancelled'*) return 1 ;;
+        esac
+        sleep 0.1
+    done
+    return 1
+}
+
+fail() {
+    kill "$guest_pid" 2>/dev/null
+    wait "$guest_pid" 2>/dev/null
+    exit 1
+}
+
+start=$EPOCHREALTIME
+if [ -n "$restore" ]; then
+    # 恢复出来的guest停在已经打印过的提示符处，发一个空行让sh重新打印提示符；
+    # 状态还没加载完时串口输入可能被丢掉，等不到就再发一次
+    sent=0
+    while :; do
+        printf '\n' >&6
+        sent=$((sent + 1))
+        wait_prompt '$ ' $((SECONDS + 2))
+        case $? in
+        0) break ;;
+        2) fail ;;
+        esac
+        [ $SECONDS -lt $deadline ] || fail
+    done
+    # 发了不止一个空行时，前面的空行可能只是处理得慢，sh之后还会多打印几个提示符，
+    # 直接发命令的话后面的wait_prompt会匹配到这些多出来的提示符，命令和输出就错开了。
+    # 执行一条echo，等到它的输出之后的提示符，多出来的提示符都在这之前被读掉
+    if [ $sent -gt 1 ]; then
+        marker=xv6-run-sync-$$
+        printf 'echo %s\n' "$marker" >&6
+        until [[ $'\n'$output == *$'\n'"$marker"$'\n'* ]]; do
+            wait_prompt || fail
+        done
+    fi
+else
+    wait_prompt || fail
+fi
+printf 'boot\t%s\t%s\n' "$(elapsed "$start")" "$(cpu_elapsed 0)" >&4
+
+for cmd in "$@"; do
+    start=$EPOCHREALTIME
+    start_cpu=$(cpu_ticks)
+    printf '%s\n' "$cmd" >&6
+    wait_prompt || fail
+    printf 'cmd\t%s\t%s\t%s\n' "$(elapsed "$start")" "$(cpu_elapsed "$start_cpu")" "$cmd" >&4
+done
+
+if [ -n "$save" ]; then
+    start=$EPOCHREALTIME
+    save_state || { echo "xv6-run: failed to save the VM state to $save" >&2; fail; }
+    printf 'save\t%s\n' "$(elapsed "$start")" >&4
+fi
+
+# Ctrl-A x让QEMU正常退出（PGO的插桩版本要靠正常退出才会写出profile）
+printf '\001x' >&6
+cat <&5 >&3
+wait "$guest_pid"
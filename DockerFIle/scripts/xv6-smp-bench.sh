@@ -0,0 +1,69 @@
+#!/bin/bash
+# xv6-smp-bench：在1、2、4、8个hart下分别运行同一份多进程负载，统计耗时和宿主机CPU利用率
+# 默认负载是smpload：PARALLEL个工作进程，每个固定做ITERS次fork/计算/管道回传，重复ROUNDS轮，
+# 总工作量与hart数量和调度顺序无关，耗时的变化就是多核带来的加速。
+# 把实验目录复制到临时目录，加入smpload用户程序后编译kernel/kernel和fs.img，不会改动实验目录
+#
+# 用法：在实验目录下执行 xv6-smp-bench [-p parallel] [-i iters] [-r rounds] [-c "1 2 4 8"] [-a multi|single] [-w cmd]
+#   -p  同时运行的工作进程数，默认 8
+#   -i  每个工作进程的迭代次数，默认 20
+#   -r  重复轮数，默认 5
+#   -c  要测试的hart数量，默认 "1 2 4 8"（xv6的NCPU是8）
+#   -a  TCG的线程模式，默认 multi（每个hart一个宿主机线程），single是所有hart轮流在一个线程上模拟，用来对比
+#   -w  自定义每轮执行的xv6命令，代替smpload（工作量需要自己保证与hart数量无关）
+# 环境变量：QEMU（默认qemu-system-riscv64）
+
+set -euo pipefail
+
+export QEMU=${QEMU:-qemu-system-riscv64}
+parallel=8
+iters=20
+rounds=5
+harts="1 2 4 8"
+accel=multi
+workload=
+
+while getopts "p:i:r:c:a:w:" opt; do
+    case $opt in
+    p) parallel=$OPTARG ;;
+    i) iters=$OPTARG ;;
+    r) rounds=$OPTARG ;;
+    c) harts=$OPTARG ;;
+    a) accel=$OPTARG ;;
+    w) workload=$OPTARG ;;
+    *) sed -n '7,14s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+workload=${workload:-smpload $parallel $iters}
+# QEMU 5.1在x86宿主机上默认就是多线程TCG，两种模式都显式指定
+export QEMUEXTRA="${QEMUEXTRA:-} -accel tcg,thread=$accel"
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# 1.在副本里加入smpload，不改动实验目录
+xv6-addprog "$work/src" smpload.c
+
+# 2.依次用不同的hart数量运行
+cmds=()
+for ((i = 0; i < rounds; i++)); do
+    cmds+=("$workload")
+done
+
+echo "QEMU=$QEMU tcg,thread=$accel workload: $rounds x '$workload'"
+printf '%6s %10s %10s %8s %8s\n' harts wall\(s\) cpu\(s\) util speedup
+base=
+for n in $harts; do
+    if ! xv6-run -s -c "$n" -k "$work/src/kernel/kernel" -f "$work/src/fs.img" -l "$work/log.$n" \
+        -T "$work/timings.$n" "${cmds[@]}" ||
+        { [ "$workload" = "smpload $parallel $iters" ] &&
+            [ "$(grep -c 'smpload: ok' "$work/log.$n")" -ne "$rounds" ]; }; then
+        echo "xv6-smp-bench: run with $n harts failed, guest output:" >&2
+        tail -20 "$work/log.$n" >&2
+        exit 1
+    fi
+    read -r wall cpu < <(awk -F'\t' '$1 == "cmd" { w += $2; c += $3 } END { printf "%.3f %.3f\n", w, c }' "$work/timings.$n")
+    base=${base:-$wall}
+    awk -v n="$n" -v w="$wall" -v c="$cpu" -v b="$base" \
+        'BEGIN { printf "%6d %10.3f %10.3f %7.0f%% %7.2fx\n", n, w, c, 100 * c / w, b / w }'
+done
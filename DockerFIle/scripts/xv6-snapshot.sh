@@ -0,0 +1,133 @@
+#!/bin/bash
+# xv6-snapshot：启动到shell提示符的xv6虚拟机状态缓存，测试时直接从缓存恢复，跳过内核启动
+#   缓存按内核、fs.img的sha256、hart数量和QEMU版本区分，放在XV6_SNAPSHOT_DIR/<key>/下：
+#     disk.qcow2  启动完成时的磁盘（fs.img转换成的qcow2，第一次启动时init会创建console设备文件）
+#     state       用xv6-run -S保存的虚拟机状态
+#   每次运行在disk.qcow2上叠一层临时overlay，再用xv6-run -R从state恢复，缓存本身不会被修改。
+#   运行期间持有缓存目录的共享锁，淘汰旧缓存时只删没人在用的，所以可以并发使用。
+#   缓存建好后会先试恢复一次，验证不通过（例如QEMU版本太老、RISC-V的CPU或中断控制器还没有迁移支持）
+#   就按QEMU版本记下来，之后用这个QEMU时都直接冷启动，不会每换一个内核都再试一遍
+#
+# 用法：xv6-snapshot [-k kernel] [-f fs.img] [-c cpus] [-t timeout] [-l log] [-T timings] [--] [cmd...]
+#   参数含义同xv6-run，guest的写入只落在临时overlay上，不会改动fs.img
+# 环境变量：
+#   XV6_SNAPSHOT_DIR   缓存目录，默认~/.cache/xv6-snapshot
+#   XV6_SNAPSHOT_KEEP  最多保留的缓存数量，默认8，每份缓存的大小约等于guest内存（128M）
+#   QEMU               同xv6-run
+
+set -euo pipefail
+
+XV6_SNAPSHOT_DIR=${XV6_SNAPSHOT_DIR:-$HOME/.cache/xv6-snapshot}
+XV6_SNAPSHOT_KEEP=${XV6_SNAPSHOT_KEEP:-8}
+QEMU=${QEMU:-qemu-system-riscv64}
+
+kernel=kernel/kernel
+fs=fs.img
+cpus=3
+run_args=()
+
+while getopts "k:f:c:t:l:T:" opt; do
+    case $opt in
+    k) kernel=$OPTARG ;;
+    f) fs=$OPTARG ;;
+    c) cpus=$OPTARG ;;
+    t | l | T) run_args+=(-"$opt" "$OPTARG") ;;
+    *) sed -n '11,16s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+key=$({
+    sha256sum <"$kernel"
+    sha256sum <"$fs"
+    echo "cpus=$cpus"
+    "$QEMU" --version | head -1
+} | sha256sum | cut -c1-16)
+cache=$XV6_SNAPSHOT_DIR/$key
+
+# 不支持恢复的QEMU只需要试一次，标记按QEMU版本区分
+unsupported=$XV6_SNAPSHOT_DIR/.unsupported-$("$QEMU" --version | head -1 | sha256sum | cut -c1-16)
+
+# .lock只在查找、放入和淘汰缓存时短暂持有；缓存已存在时拿到它的共享锁（fd 8），一直持有到运行结束
+use_cache() {
+    local found=1
+    flock 9
+    if [ -e "$cache/state" ]; then
+        exec 8<"$cache"
+        flock -s 8
+        touch "$cache"
+        found=0
+    fi
+    flock -u 9
+    return $found
+}
+
+# 按最近使用时间淘汰旧缓存，持有.lock时调用；拿不到排他锁说明还有人在用，留到下次
+evict() {
+    local old
+    ls -1t "$XV6_SNAPSHOT_DIR" | tail -n +$((XV6_SNAPSHOT_KEEP + 1)) | while read -r old; do
+        (exec 7<"$XV6_SNAPSHOT_DIR/$old" && flock -n -x 7 && rm -rf "${XV6_SNAPSHOT_DIR:?}/$old") || true
+    done
+}
+
+# 冷启动建缓存，建好后恢复一次验证
+build_cache() {
+    local tmp
+    tmp=$(mktemp -d "$XV6_SNAPSHOT_DIR/.build.XXXXXX")
+    echo "xv6-snapshot: building snapshot $key" >&2
+    if ! qemu-img convert -O qcow2 "$fs" "$tmp/disk.qcow2" ||
+        ! xv6-run -k "$kernel" -f "$tmp/disk.qcow2" -c "$cpus" -l "$tmp/build.log" -S "$tmp/state"; then
+        # 内核本身启动不了，与QEMU无关，不做标记，直接冷启动把错误交给用户看
+        echo "xv6-snapshot: booting $kernel failed, running without a snapshot" >&2
+        rm -rf "$tmp"
+        return
+    fi
+    # CPU状态没有迁移过来时guest会从复位向量重新执行，在旧内存上重跑一遍main也可能走到提示符，
+    # 所以除了命令能执行，还要确认内核没有重新启动
+    if qemu-img create -q -f qcow2 -F qcow2 -b "$tmp/disk.qcow2" "$tmp/verify.qcow2" &&
+        xv6-run -k "$kernel" -f "$tmp/verify.qcow2" -c "$cpus" -t 30 -l "$tmp/verify.log" -R "$tmp/state" \
+            "echo xv6 snapshot ok" &&
+        grep -qx 'xv6 snapshot ok' "$tmp/verify.log" &&
+        ! grep -q 'xv6 kernel is booting' "$tmp/verify.log"; then
+        rm -f "$tmp/verify.qcow2" "$tmp"/*.log
+        flock 9
+        mv "$tmp" "$cache"
+        evict
+        flock -u 9
+    else
+        echo "xv6-snapshot: restoring the snapshot failed, $QEMU cannot migrate this guest;" \
+            "falling back to cold boots with this QEMU" >&2
+        touch "$unsupported"
+        rm -rf "$tmp"
+    fi
+}
+
+mkdir -p "$XV6_SNAPSHOT_DIR"
+exec 9>"$XV6_SNAPSHOT_DIR/.lock"
+cached=0
+if [ ! -e "$unsupported" ]; then
+    if use_cache; then
+        cached=1
+    else
+        # 同一时间只建一份缓存，等锁期间别人可能已经建好了同一个key
+        exec 7>"$XV6_SNAPSHOT_DIR/.build.lock"
+        flock 7
+        if use_cache; then
+            cached=1
+        elif [ ! -e "$unsupported" ]; then
+            build_cache
+            use_cache && cached=1
+        fi
+        exec 7>&-
+    fi
+fi
+exec 9>&-
+
+if [ $cached = 0 ]; then
+    exec xv6-run -k "$kernel" -f "$fs" -c "$cpus" -s "${run_args[@]}" "$@"
+fi
+
+overlay=$(mktemp --suffix=.qcow2)
+trap 'rm -f "$overlay"' EXIT
+qemu-img create -q -f qcow2 -F qcow2 -b "$cache/disk.qcow2" "$overlay"
+xv6-run -k "$kernel" -f "$overlay" -c "$cpus" -R "$cache/state" "${run_args[@]}" "$@"
@@ -0,0 +1,45 @@
+#!/bin/bash
+# xv6-workspace-bench：对比直接在挂载目录里编译和用xv6-workspace在XV6_BUILD_DIR里编译的耗时
+# 两种方式各跑RUNS次：make clean后完整编译kernel/kernel和fs.img，再启动xv6到shell提示符，取中位数
+# 注意：会对实验目录执行make clean
+#
+# 用法：在实验目录下执行 xv6-workspace-bench [runs]，runs默认3
+# 环境变量：XV6_BUILD_DIR（同xv6-workspace）
+
+set -euo pipefail
+
+runs=${1:-3}
+src=$PWD
+fast=${XV6_BUILD_DIR:-/xv6-build}/$(basename "$src")
+jobs=$(nproc)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+seconds() {
+    local start=$EPOCHREALTIME
+    "$@" >/dev/null
+    awk -v a="$start" -v b="$EPOCHREALTIME" 'BEGIN { printf "%.3f\n", b - a }'
+}
+
+median() {
+    sort -n | awk '{ a[NR] = $1 } END { printf "%.3f", NR % 2 ? a[(NR + 1) / 2] : (a[NR / 2] + a[NR / 2 + 1]) / 2 }'
+}
+
+# $1是模式名，$2是编译目录，其余是执行编译的命令
+bench() {
+    local mode=$1 dir=$2 i
+    shift 2
+    for ((i = 0; i < runs; i++)); do
+        make -C "$src" clean >/dev/null
+        [ -f "$dir/Makefile" ] && make -C "$dir" clean >/dev/null
+        seconds "$@" -j"$jobs" kernel/kernel fs.img >>"$work/$mode.build"
+        xv6-run -k "$dir/kernel/kernel" -f "$dir/fs.img" -l /dev/null -T "$work/timings"
+        awk -F'\t' '$1 == "boot" { print $2 }' "$work/timings" >>"$work/$mode.boot"
+    done
+    printf '%-10s %10s %10s  %s\n' "$mode" "$(median <"$work/$mode.build")" "$(median <"$work/$mode.boot")" "$dir"
+}
+
+echo "kernel + fs.img build and boot, median of $runs runs (seconds)"
+printf '%-10s %10s %10s  %s\n' mode build boot dir
+bench bind "$src" make
+bench workspace "$fast" xv6-workspace
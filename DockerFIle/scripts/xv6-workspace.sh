@@ -0,0 +1,42 @@
+#!/bin/bash
+# xv6-workspace：源码留在挂载进来的宿主机目录里，编译产物和fs.img放在容器本地的XV6_BUILD_DIR里编译
+# 每次先用rsync把源码的改动同步过去（保留时间戳，make只会重新编译改过的文件），再在那边执行make。
+# 编译产物不会被同步，也不会被--delete删掉。排除列表只写xv6 Makefile生成的文件，并且都从实验目录根开始匹配；
+# 不能直接用.gitignore，它里面的mkfs（x86 xv6遗留的）不带斜杠，rsync会把整个mkfs/源码目录也排除掉
+# XV6_BUILD_DIR建议挂tmpfs或命名volume，例如：
+#   docker run --tmpfs /xv6-build:exec,uid=1000,size=1g ...    （tmpfs默认是noexec，mkfs需要在上面执行）
+#   docker run -v xv6-build:/xv6-build ...
+#
+# 用法：在实验目录下把make换成xv6-workspace，例如 xv6-workspace qemu、xv6-workspace grade
+# 环境变量：XV6_BUILD_DIR（默认/xv6-build），实际编译目录是$XV6_BUILD_DIR/<实验目录名>
+
+set -euo pipefail
+
+XV6_BUILD_DIR=${XV6_BUILD_DIR:-/xv6-build}
+
+src=$PWD
+dst=$XV6_BUILD_DIR/$(basename "$src")
+
+if [ ! -f "$src/Makefile" ] || [ ! -d "$src/kernel" ]; then
+    echo "xv6-workspace: $src does not look like an xv6 lab checkout" >&2
+    exit 2
+fi
+
+excludes=(/.git/ /fs.img /mkfs/mkfs /.gdbinit '/xv6.out*'
+    '/kernel/*.o' '/kernel/*.d' '/kernel/*.asm' '/kernel/*.sym' /kernel/kernel
+    '/user/*.o' '/user/*.d' '/user/*.asm' '/user/*.sym' '/user/_*' /user/usys.S /user/initcode /user/initcode.out)
+
+mkdir -p "$dst"
+rsync -a --delete "${excludes[@]/#/--exclude=}" "$src/" "$dst/"
+# git跟踪的源码都应该同步过去了，排除列表误伤源码时在这里报出来，而不是让make报找不到规则
+if git -C "$src" rev-parse --git-dir >/dev/null 2>&1; then
+    missing=$(git -C "$src" ls-files | while IFS= read -r f; do
+        [ ! -e "$src/$f" ] || [ -e "$dst/$f" ] || echo "$f"
+    done)
+    if [ -n "$missing" ]; then
+        echo "xv6-workspace: tracked files were not synced to $dst:" >&2
+        echo "$missing" >&2
+        exit 1
+    fi
+fi
+exec make -C "$dst" "$@"
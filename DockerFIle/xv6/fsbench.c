@@ -0,0 +1,90 @@
+// fsbench：xv6-disk-bench使用的文件系统负载，编译进xv6的用户程序，耗时由宿主机统计
+//   fsbench write <files> <blocks>  依次创建files个文件，每个顺序写入blocks个块
+//   fsbench read <files> <blocks>   把write写的文件依次读回来
+//   fsbench create <n>              创建n个空文件再全部删除，每次都要走一遍日志提交
+// 默认xv6的单个文件最多268个块（NDIRECT + NINDIRECT）
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+#define BLOCK 1024
+
+char buf[BLOCK];
+
+void
+name(char *s, char prefix, int i)
+{
+  s[0] = 'f';
+  s[1] = prefix;
+  s[2] = '0' + i / 100 % 10;
+  s[3] = '0' + i / 10 % 10;
+  s[4] = '0' + i % 10;
+  s[5] = 0;
+}
+
+void
+rw(int wr, int files, int blocks)
+{
+  char path[6];
+  int f, b, fd;
+
+  for(f = 0; f < files; f++){
+    name(path, 'w', f);
+    fd = open(path, wr ? O_CREATE | O_WRONLY : O_RDONLY);
+    if(fd < 0){
+      printf("fsbench: cannot open %s\n", path);
+      exit(1);
+    }
+    for(b = 0; b < blocks; b++){
+      if(wr){
+        memset(buf, b, sizeof(buf));
+        if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+          printf("fsbench: write %s failed\n", path);
+          exit(1);
+        }
+      } else if(read(fd, buf, sizeof(buf)) != sizeof(buf)){
+        printf("fsbench: read %s failed\n", path);
+        exit(1);
+      }
+    }
+    close(fd);
+  }
+}
+
+void
+create(int n)
+{
+  char path[6];
+  int i, fd;
+
+  for(i = 0; i < n; i++){
+    name(path, 'c', i);
+    if((fd = open(path, O_CREATE | O_WRONLY)) < 0){
+      printf("fsbench: cannot create %s\n", path);
+      exit(1);
+    }
+    close(fd);
+  }
+  for(i = 0; i < n; i++){
+    name(path, 'c', i);
+    unlink(path);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc == 4 && strcmp(argv[1], "write") == 0)
+    rw(1, atoi(argv[2]), atoi(argv[3]));
+  else if(argc == 4 && strcmp(argv[1], "read") == 0)
+    rw(0, atoi(argv[2]), atoi(argv[3]));
+  else if(argc == 3 && strcmp(argv[1], "create") == 0)
+    create(atoi(argv[2]));
+  else {
+    printf("usage: fsbench write|read <files> <blocks> | fsbench create <n>\n");
+    exit(1);
+  }
+  printf("fsbench: ok\n");
+  exit(0);
+}
@@ -0,0 +1,82 @@
+// smpload：xv6-smp-bench使用的多核负载，编译进xv6的用户程序，总工作量只由参数决定，
+// 与hart数量和进程的调度顺序无关
+//   smpload <procs> <iters>  创建procs个工作进程，每个进程重复iters次：fork一个子进程做固定次数的计算，
+//                            结果通过管道写回，父进程读出后wait回收
+// 同时存在的进程最多1 + 2*procs个，不能超过NPROC（64）
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define WORK 100000
+
+uint
+compute(uint seed)
+{
+  uint x = seed;
+  int i;
+
+  for(i = 0; i < WORK; i++)
+    x = x * 1103515245 + 12345;
+  return x;
+}
+
+void
+worker(int id, int iters)
+{
+  int i, p[2], pid;
+  uint x;
+
+  for(i = 0; i < iters; i++){
+    if(pipe(p) < 0){
+      printf("smpload: pipe failed\n");
+      exit(1);
+    }
+    if((pid = fork()) < 0){
+      printf("smpload: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      close(p[0]);
+      x = compute(id * iters + i);
+      write(p[1], &x, sizeof(x));
+      exit(0);
+    }
+    close(p[1]);
+    if(read(p[0], &x, sizeof(x)) != sizeof(x)){
+      printf("smpload: short read\n");
+      exit(1);
+    }
+    close(p[0]);
+    wait(0);
+  }
+  exit(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int procs, iters, i, status, failed = 0;
+
+  if(argc != 3 || (procs = atoi(argv[1])) < 1 || procs > 30 || (iters = atoi(argv[2])) < 1){
+    printf("usage: smpload <procs 1-30> <iters>\n");
+    exit(1);
+  }
+  for(i = 0; i < procs; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("smpload: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0)
+      worker(i, iters);
+  }
+  for(i = 0; i < procs; i++){
+    wait(&status);
+    failed |= status;
+  }
+  if(failed){
+    printf("smpload: worker failed\n");
+    exit(1);
+  }
+  printf("smpload: ok\n");
+  exit(0);
+}